@@ -15,8 +15,23 @@ PYBIND11_PLUGIN(urbg2o) {
     m.def("poseOptimization", &poseOptimization, "pose-only bundle adjustment",
 	py::arg("coords").noconvert(), py::arg("pose"));
     
-    m.def("localBundleAdjustment", &localBundleAdjustment, "local bundle adjustment",
-    py::arg("keyframes"), py::arg("fixedKeyframes"), py::arg("worldMapPoints"), py::arg("pointsRelation"));
+    m.def("localBundleAdjustment", [](Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation, int threads) {
+        return localBundleAdjustment(keyframes, fixedKeyframes, worldMapPoints, pointsRelation, threads);
+    }, "local bundle adjustment, threads = 0 runs the stock g2o solver",
+    py::arg("keyframes"), py::arg("fixedKeyframes"), py::arg("worldMapPoints"), py::arg("pointsRelation"), py::arg("threads") = 0);
+
+    m.def("localBundleAdjustmentTimed", [](Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation, int threads) {
+        double optimizeSeconds = 0;
+        int result = localBundleAdjustment(keyframes, fixedKeyframes, worldMapPoints, pointsRelation, threads, &optimizeSeconds);
+        return py::make_tuple(result, optimizeSeconds);
+    }, "local bundle adjustment, also returns the wall time of the optimizer runs",
+    py::arg("keyframes"), py::arg("fixedKeyframes"), py::arg("worldMapPoints"), py::arg("pointsRelation"), py::arg("threads") = 0);
+
+#ifdef _OPENMP
+    m.attr("openmp") = py::bool_(true);
+#else
+    m.attr("openmp") = py::bool_(false);
+#endif
 
     return m.ptr();
 }
@@ -6,10 +6,13 @@
 //#include "g2o/solvers/linear_solver_dense.h"
 #include "g2o/solvers/dense/linear_solver_dense.h"
 
+#include <chrono>
+
 #include <opencv2/core/core.hpp>
 #include <Eigen/StdVector>
 
 #include "local_ba.h"
+#include "parallel_block_solver.h"
 
 using namespace std;
 
@@ -120,7 +123,7 @@ std::vector<std::pair<KeyFrame, int>> getObservationsWithRelation(MapPoint point
     return returnKeyframes;
 }
 
-int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation )  {
+int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation, int threads, double* optimizeSeconds )  {
     //primary keyframe
     KeyFrame primaryKeyframe;
     Eigen::MatrixXd primKeyFrame(4, 4);
@@ -211,7 +214,13 @@ int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eige
     
     linearSolver = new g2o::LinearSolverEigen<g2o::BlockSolver_6_3::PoseMatrixType>();
     
-    g2o::BlockSolver_6_3 * solver_ptr = new g2o::BlockSolver_6_3(linearSolver);
+    // threads = 0 keeps the stock solver, otherwise linearization and Schur reduction are spread over the threads
+    g2o::BlockSolver_6_3 * solver_ptr;
+    if (threads > 0) {
+        solver_ptr = new ParallelBlockSolver(linearSolver, threads);
+    } else {
+        solver_ptr = new g2o::BlockSolver_6_3(linearSolver);
+    }
     g2o::OptimizationAlgorithmLevenberg* solver = new g2o::OptimizationAlgorithmLevenberg(solver_ptr);
     optimizer.setAlgorithm(solver);
     
@@ -336,6 +345,8 @@ int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eige
         return  0;
     }
     
+    const std::chrono::steady_clock::time_point optimizeStart = std::chrono::steady_clock::now();
+    
     optimizer.initializeOptimization();
     optimizer.optimize(5);
     
@@ -359,6 +370,10 @@ int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eige
         optimizer.optimize(10);
     }
     
+    if (optimizeSeconds) {
+        *optimizeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - optimizeStart).count();
+    }
+    
     vector<pair<KeyFrame,MapPoint> > vToErase;
     vToErase.reserve(vpEdgesMono.size()+vpEdgesStereo.size());
     
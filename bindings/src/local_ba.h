@@ -6,6 +6,8 @@
 #include <Eigen/LU>
 #include <Eigen/StdVector>
 
-int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation ) ;
+// threads = 0 runs the stock g2o block solver, threads >= 1 the ParallelBlockSolver.
+// optimizeSeconds, when given, receives the wall time of the optimizer runs without the window setup.
+int localBundleAdjustment(Eigen::Ref<Eigen::MatrixXd> keyframes, Eigen::Ref<Eigen::MatrixXd> fixedKeyframes, Eigen::Ref<Eigen::MatrixXd> worldMapPoints, Eigen::Ref<Eigen::MatrixXd> pointsRelation, int threads = 0, double* optimizeSeconds = 0 ) ;
 
 #endif
@@ -0,0 +1,291 @@
+#include "g2o/core/sparse_optimizer.h"
+#include "g2o/core/robust_kernel.h"
+#include "g2o/types/sba/types_six_dof_expmap.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "parallel_block_solver.h"
+
+using namespace std;
+
+typedef Eigen::Map<g2o::BlockSolver_6_3::PoseMatrixType> PoseMatrixMap;
+typedef Eigen::Map<g2o::BlockSolver_6_3::PoseVectorType> PoseVectorMap;
+typedef Eigen::Map<const g2o::BlockSolver_6_3::PoseMatrixType> ConstPoseMatrixMap;
+typedef Eigen::Map<const g2o::BlockSolver_6_3::PoseVectorType> ConstPoseVectorMap;
+
+static const int PoseBlockSize = g2o::BlockSolver_6_3::PoseDim * g2o::BlockSolver_6_3::PoseDim;
+
+ParallelBlockSolver::ParallelBlockSolver(LinearSolverType* linearSolver, int numThreads) :
+    Base(linearSolver),
+    _numThreads(numThreads > 0 ? numThreads : 1),
+    _fallback(true)
+{
+}
+
+bool ParallelBlockSolver::buildStructure(bool zeroBlocks)
+{
+    if (!Base::buildStructure(zeroBlocks)) {
+        return false;
+    }
+
+    const g2o::OptimizableGraph::EdgeContainer& edges = _optimizer->activeEdges();
+
+    _fallback = !_doSchur;
+    for (size_t k = 0; k < edges.size() && !_fallback; k++) {
+        // only projections of a free, marginalized map point (vertex 0) into a pose (vertex 1)
+        const g2o::OptimizableGraph::Vertex* point = static_cast<g2o::OptimizableGraph::Vertex*>(edges[k]->vertex(0));
+        const g2o::OptimizableGraph::Vertex* pose = static_cast<g2o::OptimizableGraph::Vertex*>(edges[k]->vertex(1));
+        if (dynamic_cast<g2o::EdgeSE3ProjectXYZ*>(edges[k]) == 0
+            || !point->marginalized() || point->hessianIndex() < 0 || pose->marginalized()) {
+            _fallback = true;
+        }
+    }
+    if (_fallback) {
+        return true;
+    }
+
+    _landmarkEdges.assign(_numLandmarks, std::vector<int>());
+    _edgePose.assign(edges.size(), -1);
+    _edgeHpl.assign(edges.size(), 0);
+    _HppDiagonal.resize(_numPoses);
+    _HllDiagonal.resize(_numLandmarks);
+
+    for (int p = 0; p < _numPoses; p++) {
+        _HppDiagonal[p] = _Hpp->block(p, p);
+    }
+    for (int l = 0; l < _numLandmarks; l++) {
+        _HllDiagonal[l] = _Hll->block(l, l);
+    }
+
+    for (size_t k = 0; k < edges.size(); k++) {
+        g2o::OptimizableGraph::Edge* e = edges[k];
+        const int point = static_cast<g2o::OptimizableGraph::Vertex*>(e->vertex(0))->hessianIndex() - _numPoses;
+        const int pose = static_cast<g2o::OptimizableGraph::Vertex*>(e->vertex(1))->hessianIndex();
+
+        _landmarkEdges[point].push_back(k);
+        if (pose >= 0) {
+            _edgePose[k] = pose;
+            _edgeHpl[k] = _Hpl->block(pose, point);
+            assert(_edgeHpl[k] && "missing Hpl block for edge");
+        }
+    }
+
+    // number the Schur blocks, then resolve the pose pairs of every map point to them
+    std::vector<int> schurColumnStart(_numPoses + 1, 0);
+    _schurBlocks.clear();
+    for (int i1 = 0; i1 < _numPoses; i1++) {
+        const g2o::SparseBlockMatrixCCS<PoseMatrixType>::SparseColumn& column = _HschurTransposedCCS->blockCols()[i1];
+        schurColumnStart[i1] = _schurBlocks.size();
+        for (size_t j = 0; j < column.size(); j++) {
+            _schurBlocks.push_back(column[j].block);
+        }
+    }
+
+    _landmarkSchurOffset.assign(_numLandmarks + 1, 0);
+    _landmarkSchurIndex.clear();
+    for (int l = 0; l < _numLandmarks; l++) {
+        const HplColumn& column = _HplCCS->blockCols()[l];
+        _landmarkSchurOffset[l] = _landmarkSchurIndex.size();
+        for (size_t a = 0; a < column.size(); a++) {
+            const g2o::SparseBlockMatrixCCS<PoseMatrixType>::SparseColumn& target = _HschurTransposedCCS->blockCols()[column[a].row];
+            g2o::SparseBlockMatrixCCS<PoseMatrixType>::SparseColumn::const_iterator targetIt = target.begin();
+            for (size_t b = a; b < column.size(); b++) {
+                while (targetIt->row < column[b].row) {
+                    ++targetIt;
+                }
+                assert(targetIt != target.end() && targetIt->row == column[b].row && "missing Schur block");
+                _landmarkSchurIndex.push_back(schurColumnStart[column[a].row] + (targetIt - target.begin()));
+            }
+        }
+    }
+    _landmarkSchurOffset[_numLandmarks] = _landmarkSchurIndex.size();
+
+    // split the map points into partitions with about the same number of edges
+    _partitionBegin.assign(_numThreads + 1, _numLandmarks);
+    _partitionBegin[0] = 0;
+    size_t seenEdges = 0;
+    int partition = 1;
+    for (int l = 0; l < _numLandmarks && partition < _numThreads; l++) {
+        seenEdges += _landmarkEdges[l].size();
+        while (partition < _numThreads && seenEdges * _numThreads >= partition * edges.size()) {
+            _partitionBegin[partition++] = l + 1;
+        }
+    }
+
+    const size_t accumulatorSize = std::max(_numPoses * PoseBlockSize, (int)_schurBlocks.size() * PoseBlockSize) + _sizePoses;
+    _accumulators.assign(_numThreads, std::vector<double>(accumulatorSize + 2 * CacheLineDoubles, 0.));
+    _jacobianWorkspaces.assign(_numThreads, _optimizer->jacobianWorkspace());
+
+    return true;
+}
+
+bool ParallelBlockSolver::buildSystem()
+{
+    if (_fallback) {
+        return Base::buildSystem();
+    }
+
+    const g2o::OptimizableGraph::EdgeContainer& edges = _optimizer->activeEdges();
+    double* const landmarkB = _b + _sizePoses;
+    const int poseGradientOffset = _numPoses * PoseBlockSize;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_numThreads) schedule(static, 1)
+#endif
+    for (int partition = 0; partition < _numThreads; partition++) {
+        g2o::JacobianWorkspace& jacobianWorkspace = _jacobianWorkspaces[partition];
+        double* acc = accumulator(partition);
+        std::fill(acc, acc + poseGradientOffset + _sizePoses, 0.);
+
+        for (int l = _partitionBegin[partition]; l < _partitionBegin[partition + 1]; l++) {
+            const std::vector<int>& lEdges = _landmarkEdges[l];
+
+            for (size_t i = 0; i < lEdges.size(); i++) {
+                if (_edgeHpl[lEdges[i]]) {
+                    _edgeHpl[lEdges[i]]->setZero();
+                }
+            }
+
+            LandmarkMatrixType H = LandmarkMatrixType::Zero();
+            LandmarkVectorType b = LandmarkVectorType::Zero();
+            for (size_t i = 0; i < lEdges.size(); i++) {
+                const int k = lEdges[i];
+
+                // EdgeSE3ProjectXYZ::linearizeOplus() hides the workspace overload, call it on the base
+                edges[k]->linearizeOplus(jacobianWorkspace);
+                const g2o::EdgeSE3ProjectXYZ* e = static_cast<const g2o::EdgeSE3ProjectXYZ*>(edges[k]);
+
+                // the errors are up to date, computeActiveErrors() runs before buildSystem()
+                Eigen::Matrix2d omega = e->information();
+                Eigen::Vector2d omega_r = - omega * e->error();
+                if (e->robustKernel()) {
+                    Eigen::Vector3d rho;
+                    e->robustKernel()->robustify(e->chi2(), rho);
+                    omega *= rho[1];
+                    omega_r *= rho[1];
+                }
+
+                const g2o::EdgeSE3ProjectXYZ::JacobianXiOplusType& A = e->jacobianOplusXi();
+                H.noalias() += A.transpose() * omega * A;
+                b.noalias() += A.transpose() * omega_r;
+
+                const int pose = _edgePose[k];
+                if (pose >= 0) {
+                    const g2o::EdgeSE3ProjectXYZ::JacobianXjOplusType& B = e->jacobianOplusXj();
+                    const Eigen::Matrix<double, 6, 2> BtO = B.transpose() * omega;
+                    PoseMatrixMap(acc + pose * PoseBlockSize).noalias() += BtO * B;
+                    PoseVectorMap(acc + poseGradientOffset + _Hpp->rowBaseOfBlock(pose)).noalias() += B.transpose() * omega_r;
+                    _edgeHpl[k]->noalias() += BtO * A;
+                }
+            }
+
+            *_HllDiagonal[l] = H;
+            LandmarkVectorType::MapType(landmarkB + _Hll->rowBaseOfBlock(l)) = b;
+        }
+    }
+
+    // merge the pose blocks of the partitions in partition order
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_numThreads) schedule(static)
+#endif
+    for (int p = 0; p < _numPoses; p++) {
+        PoseMatrixType H = PoseMatrixType::Zero();
+        PoseVectorType b = PoseVectorType::Zero();
+        for (int partition = 0; partition < _numThreads; partition++) {
+            const double* acc = accumulator(partition);
+            H += ConstPoseMatrixMap(acc + p * PoseBlockSize);
+            b += ConstPoseVectorMap(acc + poseGradientOffset + _Hpp->rowBaseOfBlock(p));
+        }
+        *_HppDiagonal[p] = H;
+        PoseVectorType::MapType(_b + _Hpp->rowBaseOfBlock(p)) = b;
+    }
+
+    return true;
+}
+
+bool ParallelBlockSolver::solve()
+{
+    if (_fallback) {
+        return Base::solve();
+    }
+
+    // _Hschur = _Hpp, but keeping the pattern of _Hschur
+    _Hschur->clear();
+    _Hpp->add(_Hschur);
+
+    const double* const landmarkB = _b + _sizePoses;
+    const int numSchurBlocks = _schurBlocks.size();
+    const int coefficientOffset = numSchurBlocks * PoseBlockSize;
+
+    // every partition reduces its map points into its own Schur blocks and coefficients
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_numThreads) schedule(static, 1)
+#endif
+    for (int partition = 0; partition < _numThreads; partition++) {
+        double* acc = accumulator(partition);
+        std::fill(acc, acc + coefficientOffset + _sizePoses, 0.);
+
+        for (int l = _partitionBegin[partition]; l < _partitionBegin[partition + 1]; l++) {
+            LandmarkMatrixType& Dinv = _DInvSchur->diagonal()[l];
+            Dinv = _HllDiagonal[l]->inverse();
+            const LandmarkVectorType db = Dinv * LandmarkVectorType::ConstMapType(landmarkB + _Hll->rowBaseOfBlock(l));
+
+            const HplColumn& column = _HplCCS->blockCols()[l];
+            const int* target = _landmarkSchurIndex.data() + _landmarkSchurOffset[l];
+            for (size_t a = 0; a < column.size(); a++) {
+                const PoseLandmarkMatrixType& Bi = *column[a].block;
+                const PoseLandmarkMatrixType BDinv = Bi * Dinv;
+                PoseVectorMap(acc + coefficientOffset + _Hpp->rowBaseOfBlock(column[a].row)).noalias() += Bi * db;
+
+                for (size_t b = a; b < column.size(); b++) {
+                    PoseMatrixMap(acc + (*target++) * PoseBlockSize).noalias() -= BDinv * column[b].block->transpose();
+                }
+            }
+        }
+    }
+
+    // merge the Schur blocks of the partitions in partition order
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_numThreads) schedule(static)
+#endif
+    for (int s = 0; s < numSchurBlocks; s++) {
+        PoseMatrixType reduction = PoseMatrixType::Zero();
+        for (int partition = 0; partition < _numThreads; partition++) {
+            reduction += ConstPoseMatrixMap(accumulator(partition) + s * PoseBlockSize);
+        }
+        *_schurBlocks[s] += reduction;
+    }
+
+    // _bschur = _b - coefficients, without touching _b
+    for (int i = 0; i < _sizePoses; i++) {
+        double coefficient = 0.;
+        for (int partition = 0; partition < _numThreads; partition++) {
+            coefficient += accumulator(partition)[coefficientOffset + i];
+        }
+        _bschur[i] = _b[i] - coefficient;
+    }
+
+    if (!_linearSolver->solve(*_Hschur, _x, _bschur)) {
+        return false;
+    }
+
+    // back substitution: xl = Dinv * (bl - Hpl^T * xp)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(_numThreads) schedule(static)
+#endif
+    for (int l = 0; l < _numLandmarks; l++) {
+        const int lBase = _sizePoses + _Hll->rowBaseOfBlock(l);
+        LandmarkVectorType cl = LandmarkVectorType::ConstMapType(_b + lBase);
+
+        const HplColumn& column = _HplCCS->blockCols()[l];
+        for (HplColumn::const_iterator it = column.begin(); it != column.end(); ++it) {
+            PoseVectorType::ConstMapType xp(_x + _Hpp->rowBaseOfBlock(it->row));
+            cl.noalias() -= it->block->transpose() * xp;
+        }
+
+        LandmarkVectorType::MapType(_x + lBase) = _DInvSchur->diagonal()[l] * cl;
+    }
+
+    return true;
+}
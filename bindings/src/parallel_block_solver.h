@@ -0,0 +1,69 @@
+#ifndef URB_PARALLEL_BLOCK_SOLVER
+#define URB_PARALLEL_BLOCK_SOLVER
+
+#include <vector>
+
+#include "g2o/core/block_solver.h"
+#include "g2o/core/jacobian_workspace.h"
+
+#include <Eigen/StdVector>
+
+// Block solver for graphs made of EdgeSE3ProjectXYZ edges between poses and
+// marginalized map points. The map points are split into numThreads partitions
+// with about the same number of edges. Each partition linearizes the edges of
+// its map points, accumulates their Hessian blocks and reduces them into the
+// Schur complement, using its own Jacobian workspace and its own accumulator
+// for the pose blocks. The accumulators are padded by a cache line on both
+// sides and merged in partition order, so for a fixed thread count the result
+// is deterministic.
+//
+// Graphs containing other edge types, fixed map points or map points that are
+// not marginalized fall back to the plain g2o::BlockSolver_6_3.
+class ParallelBlockSolver : public g2o::BlockSolver_6_3 {
+public:
+    typedef g2o::BlockSolver_6_3 Base;
+
+    ParallelBlockSolver(LinearSolverType* linearSolver, int numThreads);
+
+    virtual bool buildStructure(bool zeroBlocks = false);
+    virtual bool buildSystem();
+    virtual bool solve();
+
+    int numThreads() const { return _numThreads; }
+
+protected:
+    typedef g2o::SparseBlockMatrixCCS<PoseLandmarkMatrixType>::SparseColumn HplColumn;
+
+    // doubles in a cache line, used to pad the accumulators
+    static const int CacheLineDoubles = 8;
+
+    double* accumulator(int partition) { return &_accumulators[partition][CacheLineDoubles]; }
+
+    int _numThreads;
+    bool _fallback;
+
+    // first map point of each partition, numThreads + 1 entries
+    std::vector<int> _partitionBegin;
+    // the edges keep their jacobians mapped into these between buildSystem() calls
+    std::vector<g2o::JacobianWorkspace> _jacobianWorkspaces;
+    // pose blocks and gradient (buildSystem) or Schur blocks and coefficients (solve)
+    std::vector<std::vector<double> > _accumulators;
+
+    // active edge indices per map point, in active edge order
+    std::vector<std::vector<int> > _landmarkEdges;
+    // Hessian index of the pose of each active edge, -1 when the pose is fixed
+    std::vector<int> _edgePose;
+    // Hpl block written by each active edge, 0 when the pose is fixed
+    std::vector<PoseLandmarkMatrixType*> _edgeHpl;
+    // diagonal Hpp / Hll blocks, looked up once per structure
+    std::vector<PoseMatrixType*> _HppDiagonal;
+    std::vector<LandmarkMatrixType*> _HllDiagonal;
+
+    // blocks of the upper triangular Schur complement, in _HschurTransposedCCS order
+    std::vector<PoseMatrixType*> _schurBlocks;
+    // for every map point, the _schurBlocks index of each pose pair (i <= j) in its Hpl column
+    std::vector<int> _landmarkSchurOffset;
+    std::vector<int> _landmarkSchurIndex;
+};
+
+#endif
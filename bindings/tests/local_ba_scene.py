@@ -0,0 +1,58 @@
+import numpy as np
+
+# same camera as the bindings
+CAMERA_FX = 718.856
+CAMERA_FY = 718.856
+CAMERA_CX = 607.1928
+CAMERA_CY = 185.2157
+IMAGE_WIDTH = 1241
+IMAGE_HEIGHT = 376
+
+def make_scene(n_keyframes, n_points, seed=0, step=1.0, pixel_noise=1.0, pose_noise=0.05, point_noise=0.1):
+  """
+  Synthetic local BA window of a camera driving forward along z, in the array layout of
+  localBundleAdjustment. Returns (keyframes, fixed_keyframes, mappoints, links, true_keyframes),
+  where all keyframes but the first are perturbed from true_keyframes.
+  """
+  rng = np.random.RandomState(seed)
+
+  true_poses = []
+  for k in range(n_keyframes):
+    T_cw = np.eye(4)
+    T_cw[2, 3] = -k * step
+    true_poses.append(T_cw)
+
+  depth = n_keyframes * step + 40
+  points = np.column_stack([
+    rng.uniform(-15, 15, n_points),
+    rng.uniform(-3, 3, n_points),
+    rng.uniform(5, depth, n_points)])
+
+  links = []
+  for p, X in enumerate(points):
+    for k, T_cw in enumerate(true_poses):
+      x = T_cw[:3, :3].dot(X) + T_cw[:3, 3]
+      if x[2] < 2 or x[2] > 80:
+        continue
+      u = CAMERA_FX * x[0] / x[2] + CAMERA_CX + rng.normal(0, pixel_noise)
+      v = CAMERA_FY * x[1] / x[2] + CAMERA_CY + rng.normal(0, pixel_noise)
+      if 0 <= u < IMAGE_WIDTH and 0 <= v < IMAGE_HEIGHT:
+        links.append([1000 + p, k, u, v])
+
+  keyframes = np.zeros((n_keyframes, 17))
+  true_keyframes = np.zeros((n_keyframes, 17))
+  for k, T_cw in enumerate(true_poses):
+    noisy = T_cw.copy()
+    if k > 0:
+      noisy[:3, 3] += rng.normal(0, pose_noise, 3)
+    keyframes[k, 0] = true_keyframes[k, 0] = k
+    keyframes[k, 1:] = noisy.flatten()
+    true_keyframes[k, 1:] = T_cw.flatten()
+
+  mappoints = np.column_stack([
+    1000 + np.arange(n_points),
+    points + rng.normal(0, point_noise, points.shape),
+    np.ones(n_points)])
+
+  return (np.asfortranarray(keyframes), np.zeros((0,)), np.asfortranarray(mappoints),
+    np.array(links, order='f'), true_keyframes)
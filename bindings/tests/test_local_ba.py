@@ -2,6 +2,8 @@ import unittest
 import numpy as np
 import urbg2o
 
+from tests.local_ba_scene import make_scene
+
 class LocalBA(unittest.TestCase):
   def test_local_ba(self):
     cv_keyframes = np.load('tests/fixtures/local-ba/cv_keyframes.npy')
@@ -22,6 +24,42 @@ class LocalBA(unittest.TestCase):
     result =  urbg2o.localBundleAdjustment(cv_keyframes, f_keyframes, mappoints, links)
     self.assertIsNotNone(result)
 
+  def run_scene(self, threads, scene):
+    keyframes, f_keyframes, mappoints, links, _ = scene
+    optimized = keyframes.copy(order='F')
+    result = urbg2o.localBundleAdjustment(optimized, f_keyframes, mappoints, links, threads=threads)
+    self.assertEqual(result, 1)
+    return optimized
+
+  def test_local_ba_parallel_solver(self):
+    scene = make_scene(12, 400, pose_noise=0.2)
+    keyframes, true_keyframes = scene[0], scene[4]
+
+    stock = self.run_scene(0, scene)
+    parallel = self.run_scene(1, scene)
+
+    # threads=0 runs the stock g2o block solver, the parallel solver must agree with it
+    np.testing.assert_allclose(parallel, stock, rtol=0, atol=1e-6)
+
+    # and both move the perturbed translations towards the ground truth
+    translation = [4, 8, 12]
+    error_before = np.abs(keyframes[1:, translation] - true_keyframes[1:, translation]).mean()
+    error_after = np.abs(parallel[1:, translation] - true_keyframes[1:, translation]).mean()
+    self.assertLess(error_after, 0.5 * error_before)
+
+  @unittest.skipUnless(urbg2o.openmp, 'urbg2o was built without OpenMP')
+  def test_local_ba_threads(self):
+    # the map points are split into one partition per thread
+    scene = make_scene(12, 400, pose_noise=0.2)
+    stock = self.run_scene(0, scene)
+
+    for threads in [2, 4, 8]:
+      parallel = self.run_scene(threads, scene)
+      np.testing.assert_allclose(parallel, stock, rtol=0, atol=1e-6)
+
+      # the partitions are merged in order, so a fixed thread count gives the same result
+      np.testing.assert_array_equal(self.run_scene(threads, scene), parallel)
+
 if __name__ == '__main__':
     unittest.main()
 
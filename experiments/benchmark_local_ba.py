@@ -0,0 +1,65 @@
+"""
+Optimizer wall time of urbg2o.localBundleAdjustment on a synthetic window.
+
+Only the optimizer runs are timed, the single threaded window setup is excluded. The stock
+g2o::BlockSolver_6_3 (threads=0) is reported first, with the single thread overhead of the
+ParallelBlockSolver. The scaling of the ParallelBlockSolver over 1, 2, 4, ..., N threads is
+relative to its own single thread run.
+
+Run from the repository root after building the bindings:
+  python3 experiments/benchmark_local_ba.py --keyframes 20 --points 1500
+"""
+import argparse
+import multiprocessing
+import os
+import sys
+
+import urbg2o
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bindings'))
+from tests.local_ba_scene import make_scene
+
+def thread_counts(max_threads):
+  counts = []
+  threads = 1
+  while threads < max_threads:
+    counts.append(threads)
+    threads *= 2
+  counts.append(max_threads)
+  return counts
+
+def time_local_ba(scene, threads, repeats):
+  keyframes, f_keyframes, mappoints, links, _ = scene
+  times = []
+  for _ in range(repeats):
+    optimized = keyframes.copy(order='F')
+    result, seconds = urbg2o.localBundleAdjustmentTimed(optimized, f_keyframes, mappoints, links, threads=threads)
+    if result != 1:
+      raise RuntimeError('localBundleAdjustment did not optimize the window')
+    times.append(seconds)
+  return min(times)
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser()
+  parser.add_argument('--keyframes', type=int, default=20)
+  parser.add_argument('--points', type=int, default=1500)
+  parser.add_argument('--max-threads', type=int, default=multiprocessing.cpu_count())
+  parser.add_argument('--repeats', type=int, default=5)
+  args = parser.parse_args()
+
+  if not urbg2o.openmp:
+    print('urbg2o was built without OpenMP, every thread count runs on a single thread')
+    args.max_threads = 1
+
+  scene = make_scene(args.keyframes, args.points)
+  print('{} keyframes, {} map points, {} observations'.format(args.keyframes, args.points, len(scene[3])))
+
+  stock = time_local_ba(scene, 0, args.repeats)
+  single = time_local_ba(scene, 1, args.repeats)
+  print('stock BlockSolver_6_3: {:.4f} s, ParallelBlockSolver on 1 thread: {:.4f} s ({:+.1f}%)'.format(
+    stock, single, 100 * (single / stock - 1)))
+
+  print('{:>8} {:>10} {:>8} {:>10}'.format('threads', 'time [s]', 'speedup', 'vs stock'))
+  for threads in thread_counts(args.max_threads):
+    elapsed = single if threads == 1 else time_local_ba(scene, threads, args.repeats)
+    print('{:>8} {:>10.4f} {:>8.2f} {:>10.2f}'.format(threads, elapsed, single / elapsed, stock / elapsed))